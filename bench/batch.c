@@ -0,0 +1,121 @@
+/*
+	MIT License
+
+	Copyright (c) 2021 pete-video-analysis
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+// Compares the time taken to analyze a video frame by frame and in batches of frames
+// usage: bench [width] [height] [frames]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+
+#include "pete.h"
+
+#define PETE_BENCH_FPS 30
+#define PETE_BENCH_REPETITIONS 3
+
+/*
+	Fills a frame with a slowly moving grey pattern, so that most pixels change in every frame
+*/
+static void fill_frame(uint8_t *const data, const uint16_t width, const uint16_t height, const int frame)
+{
+	for(uint16_t y = 0; y < height; y++)
+	{
+		for(uint16_t x = 0; x < width; x++)
+		{
+			double wave = sin((x + frame / 3.0) * 2 * M_PI / 40) * cos((y + frame / 6.0) * 2 * M_PI / 29);
+			int value = (int)(255 * (0.5 + 0.45 * wave)) + rand() % 3;
+			if(value > 255) value = 255;
+
+			uint8_t *const pixel = &data[((uint64_t)y * width + x) * 3];
+			pixel[0] = pixel[1] = value;
+			pixel[2] = value * 9 / 10;
+		}
+	}
+}
+
+/*
+	Returns the lowest time taken to analyze all the frames, in milliseconds per frame.
+	A batch size of 0 sends the frames one by one with pete_receive_frame.
+*/
+static double time_analysis(uint8_t **const frames, const uint32_t count, const uint32_t batch_size, const uint16_t width, const uint16_t height)
+{
+	double best = -1;
+
+	for(int i = 0; i < PETE_BENCH_REPETITIONS; i++)
+	{
+		PETE_CTX *ctx = pete_create_context(width, height, PETE_BENCH_FPS, false);
+		if(ctx == NULL) exit(1);
+
+		clock_t start = clock();
+		for(uint32_t frame = 0; frame < count; frame += batch_size == 0 ? 1 : batch_size)
+		{
+			if(batch_size == 0)
+			{
+				pete_receive_frame(frames[frame], ctx);
+			}
+			else
+			{
+				uint32_t size = count - frame < batch_size ? count - frame : batch_size;
+				pete_receive_frames(&frames[frame], size, ctx);
+			}
+		}
+		double time = (double)(clock() - start) * 1000 / CLOCKS_PER_SEC / count;
+
+		pete_free_ctx(ctx);
+		if(best < 0 || time < best) best = time;
+	}
+
+	return best;
+}
+
+int main(int argc, char **argv)
+{
+	uint16_t width = argc > 1 ? atoi(argv[1]) : 1280;
+	uint16_t height = argc > 2 ? atoi(argv[2]) : 720;
+	uint32_t count = argc > 3 ? atoi(argv[3]) : 60;
+
+	uint8_t **frames = (uint8_t**) malloc(count * sizeof(uint8_t*));
+	if(frames == NULL) return 1;
+
+	for(uint32_t i = 0; i < count; i++)
+	{
+		frames[i] = (uint8_t*) malloc((uint64_t)width * height * 3);
+		if(frames[i] == NULL) return 1;
+		fill_frame(frames[i], width, height, i);
+	}
+
+	const uint32_t batch_sizes[] = { 0, 1, 8, 30 };
+	for(int i = 0; i < 4; i++)
+	{
+		double time = time_analysis(frames, count, batch_sizes[i], width, height);
+		if(batch_sizes[i] == 0) printf("frame by frame:   %6.2f ms/frame\n", time);
+		else printf("batches of %-5u %6.2f ms/frame\n", batch_sizes[i], time);
+	}
+
+	for(uint32_t i = 0; i < count; i++) free(frames[i]);
+	free(frames);
+
+	return 0;
+}
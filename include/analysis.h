@@ -29,12 +29,26 @@
 
 /*----------------------------------------------------------------------------*/
 
-static void process_pixel(const uint8_t red, const uint8_t green, const uint8_t blue, const uint64_t idx, PETE_CTX *const ctx);
+static bool reserve_events(const uint32_t count, const uint64_t tile_pixels, PETE_CTX *const ctx);
+static void finish_batch_by_frames(uint8_t *const *const frames, const uint32_t count, const uint64_t tile_x, const uint64_t tile_y, PETE_CTX *const ctx);
+static void process_area(const uint8_t *const data, const uint64_t start_x, const uint64_t start_y, const uint64_t end_x, const uint64_t end_y, const uint64_t frame, PETE_CTX *const ctx);
+static void process_pixels(const uint8_t *const data, const uint64_t start_x, const uint64_t start_y, const uint64_t end_x, const uint64_t end_y, const uint64_t frame, PETE_CTX *const ctx);
+static void update_red_blocks(const uint64_t start_x, const uint64_t start_y, const uint64_t end_x, const uint64_t end_y, PETE_CTX *const ctx);
+static bool process_pixel(const uint8_t red, const uint8_t green, const uint8_t blue, const uint64_t idx, const uint64_t block_idx, const uint64_t frame, PETE_CTX *const ctx);
+static void prime_pixel(struct PETE_PIX *const pixel, struct PETE_RED_PIX *const red_pixel, const double relative_luminance, const double R, const double G, const double B, const uint64_t frame);
+static bool is_red_quiet(const struct PETE_RED_PIX *const red_pixel);
+static void wake_red_block(const uint64_t block_idx, const uint64_t idx, const uint64_t frame, PETE_CTX *const ctx);
 static bool is_luminance_transition(const double low_val, const double high_val);
 static bool is_red_transition(const double low_val, const bool low_sat, const double high_val, const bool high_sat);
 static bool is_flash(const PETE_DIR current_transition_direction, const struct PETE_TRANSITION last_trans);
-static void push_flash(const int start, const int end, struct PETE_FLASH flashes[4], const bool is_red, const int idx, const PETE_CTX *const ctx);
+static void push_flash(const int start, const int end, struct PETE_FLASH flashes[4], const bool is_red, const int idx, const uint64_t frame, PETE_CTX *const ctx);
 static bool are_over_three_flashes_in_one_second(struct PETE_FLASH flashes[4], const PETE_CTX *const ctx);
 static void push_transition(const int start_frame, const int end_frame, const PETE_DIR dir, struct PETE_TRANSITION *const last_trans);
+static void report_event(const int start, const bool is_red, const bool is_over_three_flashes, const int idx, const uint64_t frame, PETE_CTX *const ctx);
+static void notify_event(const struct PETE_EVENT event, const int end, const PETE_CTX *const ctx);
+static uint64_t notify_events_before(struct PETE_EVENT_BUCKET *const bucket, uint64_t event_index, const uint64_t pixel, const PETE_CTX *const ctx);
+static void sort_events(struct PETE_EVENT_BUCKET *const bucket);
+static void flush_events(const uint32_t count, PETE_CTX *const ctx);
+static int compare_events(const void *a, const void *b);
 
 #endif
\ No newline at end of file
@@ -33,13 +33,28 @@
 /*----------------------------------------------------------------------------*/
 
 typedef struct PETE_CTX PETE_CTX;
+typedef struct PETE_SCREEN PETE_SCREEN;
+
+typedef struct PETE_STATS
+{
+	// Number of pixels analyzed so far, counting each pixel once per frame
+	uint64_t processed_pixels;
+
+	// Number of those pixels that skipped the red flash analysis
+	uint64_t red_fast_path_pixels;
+
+	// Fraction of the pixels that skipped the red flash analysis (0-1)
+	double red_fast_path_ratio;
+} PETE_STATS;
 
 /*----------------------------------------------------------------------------*/
 
 // User can define these callback functions
 
 /*
-	Called when a frame has finished being processed.
+	Called when a frame has finished being processed. With pete_receive_frames, it is called for each frame of the
+	batch once the whole batch has been processed, and the context refuses new frames until pete_receive_frames
+	returns, so the next frames must be passed after that instead of from this callback.
 	parameters:
 		ctx: pointer to the context in which the frame was processed. Can be used to distinguish between contexts.
 */
@@ -69,12 +84,32 @@ extern void (*pete_notify_flash)(const int start, const int end, const int x, co
 */
 extern void (*pete_notify_over_three_flashes)(const int start, const int end, const int x, const int y, const bool is_red, const PETE_CTX *const ctx);
 
+/*
+	Called when the pre-screen finds a range of frames in which more than three flashes in one second may be detected.
+	Passing the frames outside of every range to pete_skip_frames reports the same callbacks as the full analysis within them.
+	parameters:
+		start: the first frame of the range.
+		end: the last frame of the range.
+		screen: pointer to the pre-screen in which the range was found. Can be used to distinguish between pre-screens.
+*/
+extern void (*pete_notify_candidate_range)(const int start, const int end, const PETE_SCREEN *const screen);
+
 /*----------------------------------------------------------------------------*/
 
 PETE_CTX *pete_create_context(const uint16_t width, const uint16_t height, const uint8_t fps, const bool has_alpha);
 void pete_free_ctx(PETE_CTX *ctx);
+PETE_STATS pete_get_stats(const PETE_CTX *const ctx);
+void pete_seek(const uint64_t frame, PETE_CTX *const ctx);
 
 // Defined in analysis.c
 void pete_receive_frame(uint8_t *const data, PETE_CTX *const ctx);
+void pete_receive_frames(uint8_t *const *const frames, const uint32_t count, PETE_CTX *const ctx);
+void pete_skip_frames(uint8_t *const *const frames, const uint32_t count, PETE_CTX *const ctx);
+
+// Defined in screen.c
+PETE_SCREEN *pete_create_screen(const uint16_t width, const uint16_t height, const uint8_t fps, const bool has_alpha);
+void pete_free_screen(PETE_SCREEN *screen);
+void pete_screen_frame(uint8_t *const data, PETE_SCREEN *const screen);
+void pete_finish_screen(PETE_SCREEN *const screen);
 
 #endif
\ No newline at end of file
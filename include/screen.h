@@ -0,0 +1,40 @@
+/*
+	MIT License
+
+	Copyright (c) 2021 pete-video-analysis
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+
+#ifndef SCREEN_H
+#define SCREEN_H
+
+#include "types.h"
+
+/*----------------------------------------------------------------------------*/
+
+static void init_screen_value(struct PETE_SCREEN_RANGE *const range, int transitions[2][4]);
+static int screen_value(struct PETE_SCREEN_RANGE *const range, int transitions[2][4], const double current, const bool is_red, const int frame, const uint8_t fps);
+static int push_possible_transitions(int transitions[2][4], const bool is_inc, const bool is_dec, const int frame, const uint8_t fps);
+static int push_possible_transition(int transitions[4], const int previous[4], const int frame, const uint8_t fps);
+static bool could_be_transition(const double low_val, const double high_val, const bool is_red);
+static void push_candidate(const int start, const int end, PETE_SCREEN *const screen);
+
+#endif
@@ -30,6 +30,24 @@
 
 /*----------------------------------------------------------------------------*/
 
+// Size of the square blocks in which red activity is summarized
+#define PETE_BLOCK_SIZE 16
+
+// Most events that are stored while processing a batch of frames. Past it, the rest
+// of the batch is processed frame by frame, so that the events can be reported right away.
+#define PETE_MAX_BATCH_EVENTS (1 << 22)
+
+// Most events that a single pixel can cause in a single frame: a flash and over three
+// flashes, both general and red
+#define PETE_MAX_PIXEL_EVENTS 4
+
+// Size of the tiles of pixels that are processed across all the frames
+// of a batch before moving on to the next tile (must be multiples of PETE_BLOCK_SIZE)
+#define PETE_TILE_WIDTH 64
+#define PETE_TILE_HEIGHT 16
+
+/*----------------------------------------------------------------------------*/
+
 enum
 {
 	PETE_CHANNEL_R,
@@ -75,16 +93,56 @@ struct PETE_PIX
 	// Nodes used as running counters of the highest
 	// and lowest points since the las transition
 	struct PETE_NODE inc_node_gen, dec_node_gen;
+
+	// The last transition
+	// If its direction opposes a new transition, it's a flash
+	struct PETE_TRANSITION last_trans_gen;
+
+	// The last 4 general flashes
+	struct PETE_FLASH flashes_gen[4];
+};
+
+// Red flash state of a pixel, kept apart from the rest so that
+// the pixels that skip the red flash analysis don't load it
+struct PETE_RED_PIX
+{
 	struct PETE_NODE inc_node_red, dec_node_red;
 	// Red nodes exclusively for saturated reds
 	struct PETE_NODE inc_node_sat_red, dec_node_sat_red;
 
-	// The last transition
-	// If its direction opposes a new transition, it's a flash
-	struct PETE_TRANSITION last_trans_gen, last_trans_red;
+	struct PETE_TRANSITION last_trans_red;
 
-	// The last 4 general and red flashes
-	struct PETE_FLASH flashes_gen[4], flashes_red[4];
+	// The last 4 red flashes
+	struct PETE_FLASH flashes_red[4];
+};
+
+struct PETE_BLOCK
+{
+	// Whether all the pixels in the block are quiet, so that pixels
+	// without red can skip the red flash analysis in this frame
+	bool is_red_quiet;
+
+	// Whether all the pixels analyzed so far in this frame are quiet
+	bool is_red_quiet_next;
+};
+
+// A notification held back while a batch of frames is processed.
+// It ends in the frame of the bucket it's stored in.
+struct PETE_EVENT
+{
+	// The pixel the event happened in
+	uint32_t pixel;
+
+	int start_frame;
+
+	bool is_red, is_over_three_flashes;
+};
+
+// The events of a single frame of a batch
+struct PETE_EVENT_BUCKET
+{
+	struct PETE_EVENT *events;
+	uint64_t count, capacity;
 };
 
 // Typedef PETE_CTX as it's user facing
@@ -101,8 +159,79 @@ typedef struct PETE_CTX
 	// The current frame
 	uint64_t current_frame;
 
-	// Dynamic array of pixels
+	// Dynamic arrays with the general and red flash state of the pixels
 	struct PETE_PIX *pixels;
+	struct PETE_RED_PIX *red_pixels;
+
+	// Dynamic array of blocks of pixels, and its size in blocks
+	struct PETE_BLOCK *blocks;
+	uint64_t blocks_width, blocks_height;
+
+	// Number of pixels analyzed, in total and skipping the red flash analysis
+	uint64_t processed_pixels, red_fast_path_pixels;
+
+	// The frame received right after seeking, which only sets the nodes of the pixels (UINT64_MAX if there is none)
+	uint64_t seek_frame;
+
+	// Whether a batch of frames is being processed, including the callbacks for its frames
+	bool is_receiving_batch;
+
+	// Whether the events are being stored until the frames of a batch have been processed
+	bool is_buffering;
+
+	// Whether the frames being processed are outside of the candidate ranges, so no event is reported
+	bool is_skipping;
+
+	// Dynamic array with the events of each frame of the current batch,
+	// and the total number of events stored in them
+	struct PETE_EVENT_BUCKET *buckets;
+	uint32_t bucket_count;
+	uint64_t event_count;
 } PETE_CTX;
 
+/*----------------------------------------------------------------------------*/
+
+// Lowest and highest values of the relative luminance or the red flash
+// value of a pixel since its last possible transition
+struct PETE_SCREEN_RANGE
+{
+	double low_val, high_val;
+};
+
+struct PETE_SCREEN_PIX
+{
+	struct PETE_SCREEN_RANGE luminance, red;
+};
+
+// For each direction, the frames of the last possible transition of a pixel in that direction and of
+// the ones before it, in alternating directions, taking each one as late as possible (newest first).
+// Kept apart from the pixels, as they are only needed when there is a possible transition.
+struct PETE_SCREEN_TRANSITIONS
+{
+	int luminance[2][4], red[2][4];
+};
+
+// Typedef PETE_SCREEN as it's user facing
+typedef struct PETE_SCREEN
+{
+	uint16_t width, height;
+
+	// For non-integer fps, round up to the nearest integer
+	uint8_t fps;
+
+	// Whether the frames will include an alpha channel or not
+	bool has_alpha;
+
+	// The current frame
+	uint64_t current_frame;
+
+	// Dynamic arrays with the values and the possible transitions of each pixel
+	struct PETE_SCREEN_PIX *pixels;
+	struct PETE_SCREEN_TRANSITIONS *transitions;
+
+	// The candidate range being built, if any
+	bool has_range;
+	int range_start, range_end;
+} PETE_SCREEN;
+
 #endif
\ No newline at end of file
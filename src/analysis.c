@@ -23,6 +23,8 @@
 */
 
 #include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
 #include "analysis.h"
 #include "utils.h"
 
@@ -39,33 +41,285 @@ void (*pete_notify_over_three_flashes)(const int start, const int end, const int
 void pete_receive_frame(uint8_t *const data, PETE_CTX *const ctx)
 {
 	if(data == NULL || ctx == NULL) return;
+	if(ctx->is_receiving_batch)
+	{
+		fprintf(stderr, "Pete error: can't receive a frame while a batch of frames is being processed.\n");
+		return;
+	}
+
+	process_area(data, 0, 0, ctx->width, ctx->height, ctx->current_frame, ctx);
+
+	ctx->current_frame++;
+	if(pete_request_next_frame != NULL)
+		pete_request_next_frame(ctx);
+}
+
+/*
+	Processes the next several frames in a video at once. Each tile of pixels is processed across all
+	the frames before moving on to the next one, so that the state of each pixel is only loaded once
+	per batch. The callbacks are called in the same order as if each frame was received separately,
+	but only once every frame of the batch has been processed. Until this method returns, the context
+	refuses any other frame or seek, so they can't be passed from the callbacks.
+	parameters:
+		frames: array of pointers to the frame buffers, in RGB8 or RGBA8 format. If any of them is NULL, no frame is processed. POINTERS ARE NOT FREED INSIDE THIS METHOD!!
+		count: the number of frames in the array
+		ctx: pointer to the context allocated for the analysis of the video
+*/
+void pete_receive_frames(uint8_t *const *const frames, const uint32_t count, PETE_CTX *const ctx)
+{
+	if(frames == NULL || ctx == NULL) return;
+	for(uint32_t i = 0; i < count; i++)
+	{
+		if(frames[i] == NULL) return;
+	}
+	if(ctx->is_receiving_batch)
+	{
+		fprintf(stderr, "Pete error: can't receive frames while a batch of frames is being processed.\n");
+		return;
+	}
+
+	// Make room for the events of every frame
+	if(count > ctx->bucket_count)
+	{
+		struct PETE_EVENT_BUCKET *buckets = (struct PETE_EVENT_BUCKET*) realloc(ctx->buckets, count * sizeof(struct PETE_EVENT_BUCKET));
+		if(buckets == NULL)
+		{
+			// Without buckets, process the frames one by one
+			fprintf(stderr, "Pete error: could not allocate event buckets. Processing frames one by one.\n");
+			for(uint32_t i = 0; i < count; i++)
+			{
+				pete_receive_frame(frames[i], ctx);
+			}
+			return;
+		}
+		for(uint32_t i = ctx->bucket_count; i < count; i++)
+		{
+			buckets[i].events = NULL;
+			buckets[i].capacity = 0;
+		}
+		ctx->buckets = buckets;
+		ctx->bucket_count = count;
+	}
+
+	for(uint32_t i = 0; i < count; i++)
+	{
+		ctx->buckets[i].count = 0;
+	}
+	ctx->event_count = 0;
+	ctx->is_receiving_batch = true;
+	ctx->is_buffering = true;
+
+	// Process each tile
+	for(uint64_t tile_y = 0; tile_y < ctx->height; tile_y += PETE_TILE_HEIGHT)
+	{
+		uint64_t end_y = tile_y + PETE_TILE_HEIGHT < ctx->height ? tile_y + PETE_TILE_HEIGHT : ctx->height;
+
+		for(uint64_t tile_x = 0; tile_x < ctx->width; tile_x += PETE_TILE_WIDTH)
+		{
+			uint64_t end_x = tile_x + PETE_TILE_WIDTH < ctx->width ? tile_x + PETE_TILE_WIDTH : ctx->width;
+
+			// If the events of the tile may not fit, the rest of the batch is processed frame by frame
+			if(!reserve_events(count, (end_x - tile_x) * (end_y - tile_y), ctx))
+			{
+				ctx->is_buffering = false;
+				finish_batch_by_frames(frames, count, tile_x, tile_y, ctx);
+				ctx->is_receiving_batch = false;
+				return;
+			}
+
+			// Process each frame for the pixels in the tile
+			for(uint32_t i = 0; i < count; i++)
+			{
+				process_area(frames[i], tile_x, tile_y, end_x, end_y, ctx->current_frame + i, ctx);
+			}
+		}
+	}
+
+	ctx->is_buffering = false;
+	flush_events(count, ctx);
+	ctx->is_receiving_batch = false;
+}
 
+/*
+	Processes the next several frames in a video like pete_receive_frames, without reporting any flash.
+	Used for the frames outside of the candidate ranges of the pre-screen.
+	parameters:
+		frames: array of pointers to the frame buffers, in RGB8 or RGBA8 format. If any of them is NULL, no frame is processed. POINTERS ARE NOT FREED INSIDE THIS METHOD!!
+		count: the number of frames in the array
+		ctx: pointer to the context allocated for the analysis of the video
+*/
+void pete_skip_frames(uint8_t *const *const frames, const uint32_t count, PETE_CTX *const ctx)
+{
+	if(frames == NULL || ctx == NULL) return;
+	for(uint32_t i = 0; i < count; i++)
+	{
+		if(frames[i] == NULL) return;
+	}
+	if(ctx->is_receiving_batch)
+	{
+		fprintf(stderr, "Pete error: can't skip frames while a batch of frames is being processed.\n");
+		return;
+	}
+
+	ctx->is_receiving_batch = true;
+	ctx->is_skipping = true;
+
+	// Process each tile
+	for(uint64_t tile_y = 0; tile_y < ctx->height; tile_y += PETE_TILE_HEIGHT)
+	{
+		uint64_t end_y = tile_y + PETE_TILE_HEIGHT < ctx->height ? tile_y + PETE_TILE_HEIGHT : ctx->height;
+
+		for(uint64_t tile_x = 0; tile_x < ctx->width; tile_x += PETE_TILE_WIDTH)
+		{
+			uint64_t end_x = tile_x + PETE_TILE_WIDTH < ctx->width ? tile_x + PETE_TILE_WIDTH : ctx->width;
+
+			for(uint32_t i = 0; i < count; i++)
+			{
+				process_area(frames[i], tile_x, tile_y, end_x, end_y, ctx->current_frame + i, ctx);
+			}
+		}
+	}
+
+	ctx->is_skipping = false;
+	for(uint32_t i = 0; i < count; i++)
+	{
+		ctx->current_frame++;
+		if(pete_request_next_frame != NULL)
+			pete_request_next_frame(ctx);
+	}
+	ctx->is_receiving_batch = false;
+}
+
+/*
+	Makes sure that every bucket has room for the events that the pixels of a tile may cause.
+	returns: false if there isn't enough memory or the limit of stored events would be exceeded
+*/
+static bool reserve_events(const uint32_t count, const uint64_t tile_pixels, PETE_CTX *const ctx)
+{
+	uint64_t needed = tile_pixels * PETE_MAX_PIXEL_EVENTS;
+	if(ctx->event_count + needed * count > PETE_MAX_BATCH_EVENTS) return false;
+
+	for(uint32_t i = 0; i < count; i++)
+	{
+		struct PETE_EVENT_BUCKET *const bucket = &(ctx->buckets[i]);
+		if(bucket->count + needed <= bucket->capacity) continue;
+
+		uint64_t capacity = bucket->capacity == 0 ? needed : bucket->capacity;
+		while(capacity < bucket->count + needed) capacity *= 2;
+
+		struct PETE_EVENT *events = (struct PETE_EVENT*) realloc(bucket->events, capacity * sizeof(struct PETE_EVENT));
+		if(events == NULL)
+		{
+			fprintf(stderr, "Pete error: could not allocate event array. Processing the rest of the batch frame by frame.\n");
+			return false;
+		}
+		bucket->events = events;
+		bucket->capacity = capacity;
+	}
+
+	return true;
+}
+
+/*
+	Finishes a batch one frame at a time, starting at the given tile, which hasn't been processed in any frame.
+	The stored events of the pixels before it are reported in between, so that the order is the same.
+*/
+static void finish_batch_by_frames(uint8_t *const *const frames, const uint32_t count, const uint64_t tile_x, const uint64_t tile_y, PETE_CTX *const ctx)
+{
+	uint64_t end_y = tile_y + PETE_TILE_HEIGHT < ctx->height ? tile_y + PETE_TILE_HEIGHT : ctx->height;
+
+	for(uint32_t i = 0; i < count; i++)
+	{
+		struct PETE_EVENT_BUCKET *const bucket = &(ctx->buckets[i]);
+		sort_events(bucket);
+
+		uint64_t event_index = 0;
+		for(uint64_t y = tile_y; y < ctx->height; y++)
+		{
+			// In the row of the tile, the pixels before it have already been processed
+			uint64_t start_x = y < end_y ? tile_x : 0;
+			if(start_x >= ctx->width) continue;
+
+			event_index = notify_events_before(bucket, event_index, y * (uint64_t)ctx->width + start_x, ctx);
+			process_pixels(frames[i], start_x, y, ctx->width, y + 1, ctx->current_frame, ctx);
+		}
+		notify_events_before(bucket, event_index, UINT64_MAX, ctx);
+
+		update_red_blocks(tile_x, tile_y, ctx->width, end_y, ctx);
+		if(end_y < ctx->height)
+			update_red_blocks(0, end_y, ctx->width, ctx->height, ctx);
+
+		ctx->current_frame++;
+		if(pete_request_next_frame != NULL)
+			pete_request_next_frame(ctx);
+	}
+}
+
+/*
+	Processes the pixels of a frame within a rectangular area, which must be aligned to blocks,
+	and updates the red activity of the blocks in the area.
+*/
+static void process_area(const uint8_t *const data, const uint64_t start_x, const uint64_t start_y, const uint64_t end_x, const uint64_t end_y, const uint64_t frame, PETE_CTX *const ctx)
+{
+	process_pixels(data, start_x, start_y, end_x, end_y, frame, ctx);
+	update_red_blocks(start_x, start_y, end_x, end_y, ctx);
+}
+
+/*
+	Processes the pixels of a frame within a rectangular area, and counts the pixels that took the fast path.
+*/
+static void process_pixels(const uint8_t *const data, const uint64_t start_x, const uint64_t start_y, const uint64_t end_x, const uint64_t end_y, const uint64_t frame, PETE_CTX *const ctx)
+{
 	uint64_t channels = ctx->has_alpha ? 4 : 3;
+	uint64_t red_fast_path_pixels = 0;
+
 	// Process each pixel
-	for(uint64_t y = 0; y < ctx->height; y++)
+	for(uint64_t y = start_y; y < end_y; y++)
 	{
-		for(uint64_t x = 0; x < ctx->width; x++)
+		for(uint64_t x = start_x; x < end_x; x++)
 		{
 			uint64_t pixel_index = (y * (uint64_t)ctx->width) + x;
 			uint64_t data_index = pixel_index * channels;
+			uint64_t block_index = (y / PETE_BLOCK_SIZE) * ctx->blocks_width + (x / PETE_BLOCK_SIZE);
 
-			process_pixel(
+			red_fast_path_pixels += process_pixel(
 				data[data_index + PETE_CHANNEL_R],
 				data[data_index + PETE_CHANNEL_G],
 				data[data_index + PETE_CHANNEL_B],
 				pixel_index,
+				block_index,
+				frame,
 				ctx
 			);
 		}
-	
 	}
 
-	ctx->current_frame++;
-	if(pete_request_next_frame != NULL)
-		pete_request_next_frame(ctx);
+	ctx->processed_pixels += (end_x - start_x) * (end_y - start_y);
+	ctx->red_fast_path_pixels += red_fast_path_pixels;
+}
+
+/*
+	Once all the pixels of the blocks in an area have been processed in a frame, the red
+	activity gathered in it decides whether the blocks can be skipped in the next one.
+*/
+static void update_red_blocks(const uint64_t start_x, const uint64_t start_y, const uint64_t end_x, const uint64_t end_y, PETE_CTX *const ctx)
+{
+	for(uint64_t block_y = start_y / PETE_BLOCK_SIZE; block_y * PETE_BLOCK_SIZE < end_y; block_y++)
+	{
+		for(uint64_t block_x = start_x / PETE_BLOCK_SIZE; block_x * PETE_BLOCK_SIZE < end_x; block_x++)
+		{
+			struct PETE_BLOCK *const block = &(ctx->blocks[block_y * ctx->blocks_width + block_x]);
+			block->is_red_quiet = block->is_red_quiet_next;
+			block->is_red_quiet_next = true;
+		}
+	}
 }
 
-static void process_pixel(const uint8_t red, const uint8_t green, const uint8_t blue, const uint64_t idx, PETE_CTX *const ctx)
+/*
+	Processes a single pixel of a frame.
+	returns: whether the pixel took the fast path, skipping the red flash analysis
+*/
+static bool process_pixel(const uint8_t red, const uint8_t green, const uint8_t blue, const uint64_t idx, const uint64_t block_idx, const uint64_t frame, PETE_CTX *const ctx)
 {
 	double R = rgb8_to_gamma_corrected_rgb(red);
 	double G = rgb8_to_gamma_corrected_rgb(green);
@@ -76,17 +330,28 @@ static void process_pixel(const uint8_t red, const uint8_t green, const uint8_t
 	
 	struct PETE_PIX *const pixel = &(ctx->pixels[idx]);
 
+	// The first frame after seeking only sets the nodes, as the frames before it are unknown
+	if(frame == ctx->seek_frame)
+	{
+		struct PETE_RED_PIX *const red_pixel = &(ctx->red_pixels[idx]);
+		prime_pixel(pixel, red_pixel, relative_luminance, R, G, B, frame);
+
+		struct PETE_BLOCK *const block = &(ctx->blocks[block_idx]);
+		block->is_red_quiet_next = block->is_red_quiet_next && is_red_quiet(red_pixel);
+		return false;
+	}
+
 	if(is_luminance_transition(pixel->dec_node_gen.value, relative_luminance))
 	{	
 		if(is_flash(PETE_DIR_INC, pixel->last_trans_gen))
 		{
-			push_flash(pixel->last_trans_gen.start_frame, ctx->current_frame, pixel->flashes_gen, false, idx, ctx);
+			push_flash(pixel->last_trans_gen.start_frame, frame, pixel->flashes_gen, false, idx, frame, ctx);
 		}
 
-		push_transition(pixel->dec_node_gen.frame, ctx->current_frame, PETE_DIR_INC, &pixel->last_trans_gen);
+		push_transition(pixel->dec_node_gen.frame, frame, PETE_DIR_INC, &pixel->last_trans_gen);
 		// Reset nodes
 		struct PETE_NODE current = {
-			.frame = ctx->current_frame,
+			.frame = frame,
 			.value = relative_luminance,
 			.saturated_red = false // unused
 		};
@@ -96,13 +361,13 @@ static void process_pixel(const uint8_t red, const uint8_t green, const uint8_t
 	{
 		if(is_flash(PETE_DIR_DEC, pixel->last_trans_gen))
 		{
-			push_flash(pixel->last_trans_gen.start_frame, ctx->current_frame, pixel->flashes_gen, false, idx, ctx);
+			push_flash(pixel->last_trans_gen.start_frame, frame, pixel->flashes_gen, false, idx, frame, ctx);
 		}
 
-		push_transition(pixel->inc_node_gen.frame, ctx->current_frame, PETE_DIR_DEC, &pixel->last_trans_gen);
+		push_transition(pixel->inc_node_gen.frame, frame, PETE_DIR_DEC, &pixel->last_trans_gen);
 		// Reset nodes
 		struct PETE_NODE current = {
-			.frame = ctx->current_frame,
+			.frame = frame,
 			.value = relative_luminance,
 			.saturated_red = false // unused
 		};
@@ -111,120 +376,198 @@ static void process_pixel(const uint8_t red, const uint8_t green, const uint8_t
 
 	if(relative_luminance >= pixel->inc_node_gen.value)
 	{
-		pixel->inc_node_gen.frame = ctx->current_frame;
+		pixel->inc_node_gen.frame = frame;
 		pixel->inc_node_gen.value = relative_luminance;
 	}
 
 	if(relative_luminance <= pixel->dec_node_gen.value)
 	{
-		pixel->dec_node_gen.frame = ctx->current_frame;
+		pixel->dec_node_gen.frame = frame;
 		pixel->dec_node_gen.value = relative_luminance;
 	}
 
 	// Red flashes
 	double red_flash_val = rgb_to_red_flash_val(R, G, B);
+	struct PETE_BLOCK *const block = &(ctx->blocks[block_idx]);
+
+	// Pixels without red in a quiet block can't have a red transition, and their nodes
+	// stay the same, except for the frames, which are caught up when the block wakes up
+	if(block->is_red_quiet)
+	{
+		if(red_flash_val == 0.0) return true;
+
+		wake_red_block(block_idx, idx, frame, ctx);
+	}
+
+	struct PETE_RED_PIX *const red_pixel = &(ctx->red_pixels[idx]);
 	bool is_saturated = is_saturated_red(R, G, B);
 
-	if(is_red_transition(pixel->dec_node_red.value, pixel->dec_node_red.saturated_red, red_flash_val, is_saturated))
+	if(is_red_transition(red_pixel->dec_node_red.value, red_pixel->dec_node_red.saturated_red, red_flash_val, is_saturated))
 	{
-		if(is_flash(PETE_DIR_INC, pixel->last_trans_red))
+		if(is_flash(PETE_DIR_INC, red_pixel->last_trans_red))
 		{
-			push_flash(pixel->last_trans_red.start_frame, ctx->current_frame, pixel->flashes_red, true, idx, ctx);
+			push_flash(red_pixel->last_trans_red.start_frame, frame, red_pixel->flashes_red, true, idx, frame, ctx);
 		}
 
-		push_transition(pixel->dec_node_red.frame, ctx->current_frame, PETE_DIR_INC, &pixel->last_trans_red);
+		push_transition(red_pixel->dec_node_red.frame, frame, PETE_DIR_INC, &red_pixel->last_trans_red);
 		// Reset nodes
 		struct PETE_NODE current = {
-			.frame = ctx->current_frame,
+			.frame = frame,
 			.value = red_flash_val,
 			.saturated_red = is_saturated
 		};
-		pixel->dec_node_red = pixel->inc_node_red = current;
-		pixel->dec_node_sat_red = pixel->inc_node_sat_red = current;
-		pixel->dec_node_sat_red.saturated_red = true;
-		pixel->inc_node_sat_red.saturated_red = true;
+		red_pixel->dec_node_red = red_pixel->inc_node_red = current;
+		red_pixel->dec_node_sat_red = red_pixel->inc_node_sat_red = current;
+		red_pixel->dec_node_sat_red.saturated_red = true;
+		red_pixel->inc_node_sat_red.saturated_red = true;
 	}
-	else if(is_red_transition(red_flash_val, is_saturated, pixel->inc_node_red.value, pixel->inc_node_red.saturated_red))
+	else if(is_red_transition(red_flash_val, is_saturated, red_pixel->inc_node_red.value, red_pixel->inc_node_red.saturated_red))
 	{
-		if(is_flash(PETE_DIR_DEC, pixel->last_trans_red))
+		if(is_flash(PETE_DIR_DEC, red_pixel->last_trans_red))
 		{
-			push_flash(pixel->last_trans_red.start_frame, ctx->current_frame, pixel->flashes_red, true, idx, ctx);
+			push_flash(red_pixel->last_trans_red.start_frame, frame, red_pixel->flashes_red, true, idx, frame, ctx);
 		}
 
-		push_transition(pixel->inc_node_red.frame, ctx->current_frame, PETE_DIR_DEC, &pixel->last_trans_red);
+		push_transition(red_pixel->inc_node_red.frame, frame, PETE_DIR_DEC, &red_pixel->last_trans_red);
 		// Reset nodes
 		struct PETE_NODE current = {
-			.frame = ctx->current_frame,
+			.frame = frame,
 			.value = red_flash_val,
 			.saturated_red = is_saturated
 		};
-		pixel->dec_node_red = pixel->inc_node_red = current;
-		pixel->dec_node_sat_red = pixel->inc_node_sat_red = current;
-		pixel->dec_node_sat_red.saturated_red = true;
-		pixel->inc_node_sat_red.saturated_red = true;
+		red_pixel->dec_node_red = red_pixel->inc_node_red = current;
+		red_pixel->dec_node_sat_red = red_pixel->inc_node_sat_red = current;
+		red_pixel->dec_node_sat_red.saturated_red = true;
+		red_pixel->inc_node_sat_red.saturated_red = true;
 	}
-	else if(is_red_transition(pixel->dec_node_sat_red.value, true, red_flash_val, is_saturated))
+	else if(is_red_transition(red_pixel->dec_node_sat_red.value, true, red_flash_val, is_saturated))
 	{
-		if(is_flash(PETE_DIR_INC, pixel->last_trans_red))
+		if(is_flash(PETE_DIR_INC, red_pixel->last_trans_red))
 		{
-			push_flash(pixel->last_trans_red.start_frame, ctx->current_frame, pixel->flashes_red, true, idx, ctx);
+			push_flash(red_pixel->last_trans_red.start_frame, frame, red_pixel->flashes_red, true, idx, frame, ctx);
 		}
 
-		push_transition(pixel->dec_node_sat_red.frame, ctx->current_frame, PETE_DIR_INC, &pixel->last_trans_red);
+		push_transition(red_pixel->dec_node_sat_red.frame, frame, PETE_DIR_INC, &red_pixel->last_trans_red);
 		// Reset nodes
 		struct PETE_NODE current = {
-			.frame = ctx->current_frame,
+			.frame = frame,
 			.value = red_flash_val,
 			.saturated_red = is_saturated
 		};
-		pixel->dec_node_red = pixel->inc_node_red = current;
-		pixel->dec_node_sat_red = pixel->inc_node_sat_red = current;
-		pixel->dec_node_sat_red.saturated_red = true;
-		pixel->inc_node_sat_red.saturated_red = true;
+		red_pixel->dec_node_red = red_pixel->inc_node_red = current;
+		red_pixel->dec_node_sat_red = red_pixel->inc_node_sat_red = current;
+		red_pixel->dec_node_sat_red.saturated_red = true;
+		red_pixel->inc_node_sat_red.saturated_red = true;
 	}
-	else if(is_red_transition(red_flash_val, is_saturated, pixel->inc_node_sat_red.value, true))
+	else if(is_red_transition(red_flash_val, is_saturated, red_pixel->inc_node_sat_red.value, true))
 	{
-		if(is_flash(PETE_DIR_DEC, pixel->last_trans_red))
+		if(is_flash(PETE_DIR_DEC, red_pixel->last_trans_red))
 		{
-			push_flash(pixel->last_trans_red.start_frame, ctx->current_frame, pixel->flashes_red, true, idx, ctx);
+			push_flash(red_pixel->last_trans_red.start_frame, frame, red_pixel->flashes_red, true, idx, frame, ctx);
 		}
 
-		push_transition(pixel->inc_node_sat_red.frame, ctx->current_frame, PETE_DIR_DEC, &pixel->last_trans_red);
+		push_transition(red_pixel->inc_node_sat_red.frame, frame, PETE_DIR_DEC, &red_pixel->last_trans_red);
 		// Reset nodes
 		struct PETE_NODE current = {
-			.frame = ctx->current_frame,
+			.frame = frame,
 			.value = red_flash_val,
 			.saturated_red = is_saturated
 		};
-		pixel->dec_node_red = pixel->inc_node_red = current;
-		pixel->dec_node_sat_red = pixel->inc_node_sat_red = current;
-		pixel->dec_node_sat_red.saturated_red = true;
-		pixel->inc_node_sat_red.saturated_red = true;
+		red_pixel->dec_node_red = red_pixel->inc_node_red = current;
+		red_pixel->dec_node_sat_red = red_pixel->inc_node_sat_red = current;
+		red_pixel->dec_node_sat_red.saturated_red = true;
+		red_pixel->inc_node_sat_red.saturated_red = true;
 	}
 
-	if(red_flash_val >= pixel->inc_node_red.value)
+	if(red_flash_val >= red_pixel->inc_node_red.value)
 	{
-		pixel->inc_node_red.frame = ctx->current_frame;
-		pixel->inc_node_red.value = red_flash_val;
+		red_pixel->inc_node_red.frame = frame;
+		red_pixel->inc_node_red.value = red_flash_val;
 	}
 
-	if(red_flash_val <= pixel->dec_node_red.value)
+	if(red_flash_val <= red_pixel->dec_node_red.value)
 	{
-		pixel->dec_node_red.frame = ctx->current_frame;
-		pixel->dec_node_red.value = red_flash_val;
+		red_pixel->dec_node_red.frame = frame;
+		red_pixel->dec_node_red.value = red_flash_val;
 	}
 
-	if(red_flash_val >= pixel->inc_node_sat_red.value && is_saturated)
+	if(red_flash_val >= red_pixel->inc_node_sat_red.value && is_saturated)
 	{
-		pixel->inc_node_sat_red.frame = ctx->current_frame;
-		pixel->inc_node_sat_red.value = red_flash_val;
+		red_pixel->inc_node_sat_red.frame = frame;
+		red_pixel->inc_node_sat_red.value = red_flash_val;
 	}
 
-	if(red_flash_val <= pixel->dec_node_sat_red.value && is_saturated)
+	if(red_flash_val <= red_pixel->dec_node_sat_red.value && is_saturated)
 	{
-		pixel->dec_node_sat_red.frame = ctx->current_frame;
-		pixel->dec_node_sat_red.value = red_flash_val;
+		red_pixel->dec_node_sat_red.frame = frame;
+		red_pixel->dec_node_sat_red.value = red_flash_val;
 	}
+
+	block->is_red_quiet_next = block->is_red_quiet_next && is_red_quiet(red_pixel);
+
+	return false;
+}
+
+/*
+	Sets every node of a pixel to its values in the current frame, the same way as after a transition.
+*/
+static void prime_pixel(struct PETE_PIX *const pixel, struct PETE_RED_PIX *const red_pixel, const double relative_luminance, const double R, const double G, const double B, const uint64_t frame)
+{
+	struct PETE_NODE luminance = {
+		.frame = frame,
+		.value = relative_luminance,
+		.saturated_red = false // unused
+	};
+	pixel->inc_node_gen = pixel->dec_node_gen = luminance;
+
+	struct PETE_NODE red = {
+		.frame = frame,
+		.value = rgb_to_red_flash_val(R, G, B),
+		.saturated_red = is_saturated_red(R, G, B)
+	};
+	red_pixel->dec_node_red = red_pixel->inc_node_red = red;
+	red_pixel->dec_node_sat_red = red_pixel->inc_node_sat_red = red;
+	red_pixel->dec_node_sat_red.saturated_red = true;
+	red_pixel->inc_node_sat_red.saturated_red = true;
+}
+
+/*
+	Returns whether a pixel is guaranteed not to have a red transition, and to keep its red
+	nodes (apart from their frames), for as long as its red flash value stays at 0.
+*/
+static bool is_red_quiet(const struct PETE_RED_PIX *const red_pixel)
+{
+	return red_pixel->inc_node_red.value == 0.0 && red_pixel->dec_node_red.value == 0.0 && red_pixel->inc_node_sat_red.value <= 20.0;
+}
+
+/*
+	Stops skipping the red flash analysis in a block, bringing the frames of the red nodes of its pixels up to date.
+	The pixels before the given one were skipped in this frame, and the rest in the previous one.
+*/
+static void wake_red_block(const uint64_t block_idx, const uint64_t idx, const uint64_t frame, PETE_CTX *const ctx)
+{
+	uint64_t block_x = block_idx % ctx->blocks_width;
+	uint64_t block_y = block_idx / ctx->blocks_width;
+
+	uint64_t start_x = block_x * PETE_BLOCK_SIZE;
+	uint64_t start_y = block_y * PETE_BLOCK_SIZE;
+	uint64_t end_x = start_x + PETE_BLOCK_SIZE < ctx->width ? start_x + PETE_BLOCK_SIZE : ctx->width;
+	uint64_t end_y = start_y + PETE_BLOCK_SIZE < ctx->height ? start_y + PETE_BLOCK_SIZE : ctx->height;
+
+	for(uint64_t y = start_y; y < end_y; y++)
+	{
+		for(uint64_t x = start_x; x < end_x; x++)
+		{
+			uint64_t pixel_index = (y * (uint64_t)ctx->width) + x;
+			struct PETE_RED_PIX *const red_pixel = &(ctx->red_pixels[pixel_index]);
+
+			int last_frame = pixel_index < idx ? frame : frame - 1;
+			red_pixel->inc_node_red.frame = last_frame;
+			red_pixel->dec_node_red.frame = last_frame;
+		}
+	}
+
+	ctx->blocks[block_idx].is_red_quiet = false;
 }
 
 static bool is_luminance_transition(const double low_val, const double high_val)
@@ -251,7 +594,7 @@ static bool is_flash(const PETE_DIR current_transition_direction, const struct P
 	return true;
 }
 
-static void push_flash(const int start, const int end, struct PETE_FLASH flashes[4], const bool is_red, const int idx, const PETE_CTX *const ctx)
+static void push_flash(const int start, const int end, struct PETE_FLASH flashes[4], const bool is_red, const int idx, const uint64_t frame, PETE_CTX *const ctx)
 {
 	flashes[3] = flashes[2];
 	flashes[2] = flashes[1];
@@ -261,17 +604,12 @@ static void push_flash(const int start, const int end, struct PETE_FLASH flashes
 
 	if(pete_notify_flash != NULL)
 	{
-		uint16_t x = idx % ctx->width;
-		uint16_t y = (idx - x) / ctx->width;
-		struct PETE_FLASH flash = flashes[0];
-		pete_notify_flash(flash.start_frame, flash.end_frame, x, y, is_red, ctx);
+		report_event(flashes[0].start_frame, is_red, false, idx, frame, ctx);
 	}
 
 	if(are_over_three_flashes_in_one_second(flashes, ctx) && pete_notify_over_three_flashes != NULL)
 	{
-		uint16_t x = idx % ctx->width;
-		uint16_t y = (idx - x) / ctx->width;
-		pete_notify_over_three_flashes(flashes[3].start_frame, flashes[0].end_frame, x, y, is_red, ctx);
+		report_event(flashes[3].start_frame, is_red, true, idx, frame, ctx);
 	}
 }
 
@@ -295,4 +633,105 @@ static void push_transition(const int start_frame, const int end_frame, const PE
 	last_trans->start_frame = start_frame;
 	last_trans->end_frame = end_frame;
 	last_trans->direction = dir;
+}
+
+/*
+	Notifies the user of an event right away, or stores it until the end of the batch if one is being processed.
+	Both kinds of events end in the current frame.
+*/
+static void report_event(const int start, const bool is_red, const bool is_over_three_flashes, const int idx, const uint64_t frame, PETE_CTX *const ctx)
+{
+	if(ctx->is_skipping) return;
+
+	struct PETE_EVENT event = {
+		.pixel = idx,
+		.start_frame = start,
+		.is_red = is_red,
+		.is_over_three_flashes = is_over_three_flashes
+	};
+
+	if(!ctx->is_buffering)
+	{
+		notify_event(event, frame, ctx);
+		return;
+	}
+
+	// There is always room, as it was reserved before processing the tile
+	struct PETE_EVENT_BUCKET *const bucket = &(ctx->buckets[frame - ctx->current_frame]);
+	bucket->events[bucket->count++] = event;
+	ctx->event_count++;
+}
+
+static void notify_event(const struct PETE_EVENT event, const int end, const PETE_CTX *const ctx)
+{
+	uint16_t x = event.pixel % ctx->width;
+	uint16_t y = (event.pixel - x) / ctx->width;
+
+	if(event.is_over_three_flashes)
+	{
+		if(pete_notify_over_three_flashes != NULL)
+			pete_notify_over_three_flashes(event.start_frame, end, x, y, event.is_red, ctx);
+	}
+	else if(pete_notify_flash != NULL)
+	{
+		pete_notify_flash(event.start_frame, end, x, y, event.is_red, ctx);
+	}
+}
+
+/*
+	Notifies the user of the stored events of the current frame, starting at the given one, up to the given pixel.
+	returns: the index of the first event that wasn't notified
+*/
+static uint64_t notify_events_before(struct PETE_EVENT_BUCKET *const bucket, uint64_t event_index, const uint64_t pixel, const PETE_CTX *const ctx)
+{
+	while(event_index < bucket->count && bucket->events[event_index].pixel < pixel)
+	{
+		notify_event(bucket->events[event_index], ctx->current_frame, ctx);
+		event_index++;
+	}
+
+	return event_index;
+}
+
+/*
+	Tiles are processed out of raster order, so the events of a frame are sorted by pixel before being notified.
+*/
+static void sort_events(struct PETE_EVENT_BUCKET *const bucket)
+{
+	qsort(bucket->events, bucket->count, sizeof(struct PETE_EVENT), compare_events);
+}
+
+/*
+	Notifies the user of the events stored during a batch, frame by frame, and advances the context past the batch.
+*/
+static void flush_events(const uint32_t count, PETE_CTX *const ctx)
+{
+	for(uint32_t i = 0; i < count; i++)
+	{
+		struct PETE_EVENT_BUCKET *const bucket = &(ctx->buckets[i]);
+		sort_events(bucket);
+		notify_events_before(bucket, 0, UINT64_MAX, ctx);
+
+		ctx->current_frame++;
+		if(pete_request_next_frame != NULL)
+			pete_request_next_frame(ctx);
+	}
+}
+
+/*
+	Orders the events of a frame by pixel. Within a pixel, general events come before red ones,
+	and flashes before over three flashes, which is the order in which they happen.
+*/
+static int compare_events(const void *a, const void *b)
+{
+	const struct PETE_EVENT *const event_a = (const struct PETE_EVENT*)a;
+	const struct PETE_EVENT *const event_b = (const struct PETE_EVENT*)b;
+
+	if(event_a->pixel != event_b->pixel)
+		return event_a->pixel < event_b->pixel ? -1 : 1;
+	if(event_a->is_red != event_b->is_red)
+		return event_a->is_red ? 1 : -1;
+	if(event_a->is_over_three_flashes != event_b->is_over_three_flashes)
+		return event_a->is_over_three_flashes ? 1 : -1;
+	return 0;
 }
\ No newline at end of file
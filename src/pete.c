@@ -28,6 +28,55 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+/*
+	Brings the pixels and blocks of a context back to their initial state, as if no frame had been analyzed before the given one
+	parameters:
+		frame: the frame from which the analysis starts
+		ctx: pointer to the context struct
+*/
+static void reset_analysis(const uint64_t frame, PETE_CTX *const ctx)
+{
+	for (uint64_t i = 0; i < ctx->blocks_width * ctx->blocks_height; ++i)
+	{
+		// No pixel is quiet until it has been analyzed
+		ctx->blocks[i].is_red_quiet = false;
+		ctx->blocks[i].is_red_quiet_next = true;
+	}
+
+	struct PETE_NODE node = {
+		.frame = frame,
+		.value = 0.0,
+		.saturated_red = false
+	};
+
+	for (uint64_t i = 0; i < ctx->width * ctx->height; ++i)
+	{
+		struct PETE_PIX *pixel = &(ctx->pixels[i]);
+		struct PETE_RED_PIX *red_pixel = &(ctx->red_pixels[i]);
+		pixel->inc_node_gen = pixel->dec_node_gen = node;
+		red_pixel->inc_node_red = red_pixel->dec_node_red = node;
+		red_pixel->inc_node_sat_red = red_pixel->dec_node_sat_red = node;
+
+		// Ensure that any valid node is lower than the
+		// down nodes at the start
+		pixel->dec_node_gen.value = 1.1;
+		red_pixel->dec_node_red.value = 1.1;
+		red_pixel->dec_node_sat_red.value = 1.1;
+
+		pixel->last_trans_gen.start_frame = -1;
+		red_pixel->last_trans_red.start_frame = -1;
+
+		// Initialize flashes with negative start frames
+		for(int j = 0; j < 3; j++)
+		{
+			pixel->flashes_gen[j].start_frame = -1;
+			red_pixel->flashes_red[j].start_frame = -1;
+		}
+	}
+
+	ctx->current_frame = frame;
+}
+
 /*
 	Creates a context struct, allocates the pointers within it and initializes necessary elements
 	parameters:
@@ -51,36 +100,53 @@ PETE_CTX *pete_create_context(const uint16_t width, const uint16_t height, const
 	ctx->height = height;
 	ctx->fps = fps;
 	ctx->has_alpha = has_alpha;
+
+	// The analysis of a new context starts from the initial nodes
+	ctx->seek_frame = UINT64_MAX;
+
+	// Events are only stored while processing a batch of frames
+	ctx->is_receiving_batch = false;
+	ctx->is_buffering = false;
+	ctx->is_skipping = false;
+	ctx->buckets = NULL;
+	ctx->bucket_count = 0;
+	ctx->event_count = 0;
 	
-	// Alocate pixels
-	ctx->pixels = (struct PETE_PIX*) malloc(width * height * sizeof(struct PETE_PIX));
+	ctx->processed_pixels = 0;
+	ctx->red_fast_path_pixels = 0;
+	
+	// Alocate pixels, with all nodes starting at 0
+	ctx->pixels = (struct PETE_PIX*) calloc(width * height, sizeof(struct PETE_PIX));
 	if(ctx->pixels == NULL)
 	{
 		fprintf(stderr, "Pete error: could not allocate pixel array. Video resolution (%ux%u) may be too large.\n", width, height);
 		free(ctx);
 		return NULL;
 	}
-
-	for (uint64_t i = 0; i < ctx->width * ctx->height; ++i)
+	ctx->red_pixels = (struct PETE_RED_PIX*) calloc(width * height, sizeof(struct PETE_RED_PIX));
+	if(ctx->red_pixels == NULL)
 	{
-		struct PETE_PIX *pixel = &(ctx->pixels[i]);
-		// Ensure that any valid node is lower than the
-		// down nodes at the start
-		pixel->dec_node_gen.value = 1.1;
-		pixel->dec_node_red.value = 1.1;
-		pixel->dec_node_sat_red.value = 1.1;
-
-		pixel->last_trans_gen.start_frame = -1;
-		pixel->last_trans_red.start_frame = -1;
+		fprintf(stderr, "Pete error: could not allocate pixel array. Video resolution (%ux%u) may be too large.\n", width, height);
+		free(ctx->pixels);
+		free(ctx);
+		return NULL;
+	}
 
-		// Initialize flashes with negative start frames
-		for(int j = 0; j < 3; j++)
-		{
-			pixel->flashes_gen[j].start_frame = -1;
-			pixel->flashes_red[j].start_frame = -1;
-		}
+	// Alocate blocks
+	ctx->blocks_width = (width + PETE_BLOCK_SIZE - 1) / PETE_BLOCK_SIZE;
+	ctx->blocks_height = (height + PETE_BLOCK_SIZE - 1) / PETE_BLOCK_SIZE;
+	ctx->blocks = (struct PETE_BLOCK*) malloc(ctx->blocks_width * ctx->blocks_height * sizeof(struct PETE_BLOCK));
+	if(ctx->blocks == NULL)
+	{
+		fprintf(stderr, "Pete error: could not allocate block array. Video resolution (%ux%u) may be too large.\n", width, height);
+		free(ctx->pixels);
+		free(ctx->red_pixels);
+		free(ctx);
+		return NULL;
 	}
 
+	reset_analysis(0, ctx);
+
 	return ctx;
 }
 
@@ -92,5 +158,60 @@ PETE_CTX *pete_create_context(const uint16_t width, const uint16_t height, const
 void pete_free_ctx(PETE_CTX *ctx)
 {
 	if(ctx->pixels != NULL) free(ctx->pixels);
+	if(ctx->red_pixels != NULL) free(ctx->red_pixels);
+	if(ctx->blocks != NULL) free(ctx->blocks);
+	if(ctx->buckets != NULL)
+	{
+		for(uint32_t i = 0; i < ctx->bucket_count; i++)
+		{
+			if(ctx->buckets[i].events != NULL) free(ctx->buckets[i].events);
+		}
+		free(ctx->buckets);
+	}
 	if(ctx != NULL) free(ctx);
+}
+
+/*
+	Restarts the analysis in a context at the given frame, as if the video started there.
+	parameters:
+		frame: the frame that will be received next
+		ctx: pointer to the context struct
+*/
+void pete_seek(const uint64_t frame, PETE_CTX *const ctx)
+{
+	if(ctx == NULL) return;
+	if(ctx->is_receiving_batch)
+	{
+		fprintf(stderr, "Pete error: can't seek while a batch of frames is being processed.\n");
+		return;
+	}
+
+	reset_analysis(frame, ctx);
+
+	// Seeking to the start is the same as a new context, which starts from the initial nodes
+	ctx->seek_frame = frame == 0 ? UINT64_MAX : frame;
+}
+
+/*
+	Returns statistics about the analysis done so far in a context.
+	parameters:
+		ctx: pointer to the context struct
+	returns:
+		the statistics of the context (all zero if ctx is NULL)
+*/
+PETE_STATS pete_get_stats(const PETE_CTX *const ctx)
+{
+	if(ctx == NULL)
+	{
+		PETE_STATS empty = { 0 };
+		return empty;
+	}
+
+	PETE_STATS stats = {
+		.processed_pixels = ctx->processed_pixels,
+		.red_fast_path_pixels = ctx->red_fast_path_pixels,
+		.red_fast_path_ratio = ctx->processed_pixels == 0 ? 0.0 : (double)ctx->red_fast_path_pixels / ctx->processed_pixels
+	};
+
+	return stats;
 }
\ No newline at end of file
@@ -0,0 +1,279 @@
+/*
+	MIT License
+
+	Copyright (c) 2021 pete-video-analysis
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <limits.h>
+#include "pete.h"
+#include "screen.h"
+#include "utils.h"
+
+void (*pete_notify_candidate_range)(const int start, const int end, const PETE_SCREEN *const screen) = NULL;
+
+/*
+	Creates a pre-screen struct, which finds the ranges of frames in a video that may contain more than three flashes
+	in one second. It only keeps the range of the values of each pixel since its last possible transition, so it's
+	much faster than the full analysis.
+	parameters:
+		width: the width of the video being analyzed, in pixels
+		height: the height of the video being analyzed, in pixels
+		fps: the fps (frames per second) of the video being analyzed (for non-integer fps, round to nearest integer)
+		has_alpha: whether the frame buffers corresponding to the video being analyzed include an alpha channel
+	returns:
+		the created and initialized PETE_SCREEN struct (may return NULL)
+*/
+PETE_SCREEN *pete_create_screen(const uint16_t width, const uint16_t height, const uint8_t fps, const bool has_alpha)
+{
+	PETE_SCREEN *screen = (PETE_SCREEN*)malloc(sizeof(PETE_SCREEN));
+	if(screen == NULL)
+	{
+		fprintf(stderr, "Pete error: could not allocate pre-screen.\n");
+		return NULL;
+	}
+
+	screen->width = width;
+	screen->height = height;
+	screen->fps = fps;
+	screen->has_alpha = has_alpha;
+	screen->current_frame = 0;
+	screen->has_range = false;
+
+	// Alocate pixels
+	screen->pixels = (struct PETE_SCREEN_PIX*) malloc(width * height * sizeof(struct PETE_SCREEN_PIX));
+	screen->transitions = (struct PETE_SCREEN_TRANSITIONS*) malloc(width * height * sizeof(struct PETE_SCREEN_TRANSITIONS));
+	if(screen->pixels == NULL || screen->transitions == NULL)
+	{
+		fprintf(stderr, "Pete error: could not allocate pixel array. Video resolution (%ux%u) may be too large.\n", width, height);
+		if(screen->pixels != NULL) free(screen->pixels);
+		if(screen->transitions != NULL) free(screen->transitions);
+		free(screen);
+		return NULL;
+	}
+
+	for(uint64_t i = 0; i < (uint64_t)width * height; i++)
+	{
+		init_screen_value(&(screen->pixels[i].luminance), screen->transitions[i].luminance);
+		init_screen_value(&(screen->pixels[i].red), screen->transitions[i].red);
+	}
+
+	return screen;
+}
+
+/*
+	Frees the pointers in a pre-screen struct before freeing the pre-screen itself.
+	parameters:
+		screen: pointer to the pre-screen struct
+*/
+void pete_free_screen(PETE_SCREEN *screen)
+{
+	if(screen == NULL) return;
+
+	if(screen->pixels != NULL) free(screen->pixels);
+	if(screen->transitions != NULL) free(screen->transitions);
+	free(screen);
+}
+
+/*
+	Pre-screens the next frame in a video. Calls pete_notify_candidate_range when a range of frames that may contain
+	more than three flashes in one second has ended.
+	parameters:
+		data: pointer to the frame buffer for the received frame, in RGB8 or RGBA8 format. POINTER IS NOT FREED INSIDE THIS METHOD!!
+		screen: pointer to the pre-screen allocated for the video
+*/
+void pete_screen_frame(uint8_t *const data, PETE_SCREEN *const screen)
+{
+	if(data == NULL || screen == NULL) return;
+
+	uint64_t channels = screen->has_alpha ? 4 : 3;
+	uint64_t pixel_count = (uint64_t)screen->width * screen->height;
+	int frame = screen->current_frame;
+
+	// Last frame in which more than three flashes that end in
+	// a possible transition of this frame could be detected
+	int candidate_end = -1;
+
+	for(uint64_t pixel_index = 0; pixel_index < pixel_count; pixel_index++)
+	{
+		uint64_t data_index = pixel_index * channels;
+
+		double R = rgb8_to_gamma_corrected_rgb(data[data_index + PETE_CHANNEL_R]);
+		double G = rgb8_to_gamma_corrected_rgb(data[data_index + PETE_CHANNEL_G]);
+		double B = rgb8_to_gamma_corrected_rgb(data[data_index + PETE_CHANNEL_B]);
+
+		struct PETE_SCREEN_PIX *const pixel = &(screen->pixels[pixel_index]);
+		struct PETE_SCREEN_TRANSITIONS *const transitions = &(screen->transitions[pixel_index]);
+
+		int luminance_end = screen_value(&(pixel->luminance), transitions->luminance, rgb_to_luminance(R, G, B), false, frame, screen->fps);
+		int red_end = screen_value(&(pixel->red), transitions->red, rgb_to_red_flash_val(R, G, B), true, frame, screen->fps);
+
+		if(luminance_end > candidate_end) candidate_end = luminance_end;
+		if(red_end > candidate_end) candidate_end = red_end;
+	}
+
+	// More than three flashes can only be detected in the frames between this one and the candidate end
+	if(candidate_end >= 0)
+		push_candidate(frame, candidate_end, screen);
+
+	screen->current_frame++;
+}
+
+/*
+	Reports the last candidate range, if there is one. Call after the last frame of the video has been pre-screened.
+	parameters:
+		screen: pointer to the pre-screen allocated for the video
+*/
+void pete_finish_screen(PETE_SCREEN *const screen)
+{
+	if(screen == NULL || !screen->has_range) return;
+
+	// The range can't go past the end of the video
+	if(screen->range_end >= (int)screen->current_frame)
+		screen->range_end = screen->current_frame - 1;
+
+	screen->has_range = false;
+	if(pete_notify_candidate_range != NULL)
+		pete_notify_candidate_range(screen->range_start, screen->range_end, screen);
+}
+
+/*
+	Starts a value with the same low and high points as the nodes of the full analysis,
+	and without any possible transition.
+*/
+static void init_screen_value(struct PETE_SCREEN_RANGE *const range, int transitions[2][4])
+{
+	range->low_val = 1.1;
+	range->high_val = 0.0;
+
+	for(int i = 0; i < 4; i++)
+	{
+		transitions[PETE_DIR_INC][i] = INT_MIN;
+		transitions[PETE_DIR_DEC][i] = INT_MIN;
+	}
+}
+
+/*
+	Updates a value of a pixel with the one of the current frame. Every transition of the full analysis, which goes from
+	the frame of a node to the frame in which it's found, contains a possible transition in the same direction, found
+	by comparing the value with the lowest and highest ones since the last possible transition.
+	More than three flashes in one second need five transitions in alternating directions, all in the
+	second before the last flash ends, so they need five possible transitions within one second as well.
+	returns: the last frame in which the full analysis could detect more than three flashes
+	ending in the possible transition of this frame, or -1 if there is none
+*/
+static int screen_value(struct PETE_SCREEN_RANGE *const range, int transitions[2][4], const double current, const bool is_red, const int frame, const uint8_t fps)
+{
+	bool is_inc = could_be_transition(range->low_val, current, is_red);
+	bool is_dec = could_be_transition(current, range->high_val, is_red);
+
+	if(!is_inc && !is_dec)
+	{
+		range->low_val = current < range->low_val ? current : range->low_val;
+		range->high_val = current > range->high_val ? current : range->high_val;
+		return -1;
+	}
+
+	range->low_val = current;
+	range->high_val = current;
+
+	return push_possible_transitions(transitions, is_inc, is_dec, frame, fps);
+}
+
+/*
+	Pushes the possible transitions found in the current frame, which can be in both directions.
+	returns: the last frame in which the full analysis could detect more than three flashes
+	ending in them, or -1 if there is none
+*/
+static int push_possible_transitions(int transitions[2][4], const bool is_inc, const bool is_dec, const int frame, const uint8_t fps)
+{
+	// The possible transitions before this one go in the opposite direction,
+	// so if there are two, both are pushed on top of the ones before this frame
+	int previous_inc[4], previous_dec[4];
+	for(int i = 0; i < 4; i++)
+	{
+		previous_inc[i] = transitions[PETE_DIR_INC][i];
+		previous_dec[i] = transitions[PETE_DIR_DEC][i];
+	}
+
+	int candidate_end = -1;
+
+	if(is_inc)
+		candidate_end = push_possible_transition(transitions[PETE_DIR_INC], previous_dec, frame, fps);
+
+	if(is_dec)
+	{
+		int end = push_possible_transition(transitions[PETE_DIR_DEC], previous_inc, frame, fps);
+		if(end > candidate_end) candidate_end = end;
+	}
+
+	return candidate_end;
+}
+
+/*
+	Sets the possible transitions in one direction to the one of the current frame, followed by the ones before it.
+	returns: the last frame in which more than three flashes could be detected if the five transitions
+	are within one second, or -1 otherwise
+*/
+static int push_possible_transition(int transitions[4], const int previous[4], const int frame, const uint8_t fps)
+{
+	int oldest = previous[3];
+
+	transitions[0] = frame;
+	transitions[1] = previous[0];
+	transitions[2] = previous[1];
+	transitions[3] = previous[2];
+
+	// The oldest flash starts before its transition is found, and the newest one can't end more than one second after that
+	if(oldest < frame - fps) return -1;
+	return oldest + fps;
+}
+
+/*
+	Like is_luminance_transition and is_red_transition, without the conditions that only make transitions less likely.
+*/
+static bool could_be_transition(const double low_val, const double high_val, const bool is_red)
+{
+	if(is_red)
+		return high_val - low_val > 20.0;
+
+	return high_val - low_val >= 0.1;
+}
+
+/*
+	Adds the frames between start and end to the candidate ranges, merging them with the current range if they touch it.
+*/
+static void push_candidate(const int start, const int end, PETE_SCREEN *const screen)
+{
+	if(screen->has_range && start <= screen->range_end + 1)
+	{
+		if(end > screen->range_end) screen->range_end = end;
+		return;
+	}
+
+	if(screen->has_range && pete_notify_candidate_range != NULL)
+		pete_notify_candidate_range(screen->range_start, screen->range_end, screen);
+
+	screen->has_range = true;
+	screen->range_start = start;
+	screen->range_end = end;
+}
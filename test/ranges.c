@@ -0,0 +1,303 @@
+/*
+	MIT License
+
+	Copyright (c) 2021 pete-video-analysis
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+// Checks that analyzing parts of a video reports the same flashes as analyzing all of it in them
+// usage: test (exits with 1 if any check fails)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pete.h"
+
+#define PETE_TEST_WIDTH 67
+#define PETE_TEST_HEIGHT 45
+#define PETE_TEST_FPS 10
+#define PETE_TEST_FRAMES 150
+#define PETE_TEST_SEEDS 8
+
+// A callback, which is called in its end frame
+struct PETE_TEST_EVENT
+{
+	int start, end, x, y;
+	bool is_red, is_over_three_flashes;
+};
+
+struct PETE_TEST_LOG
+{
+	struct PETE_TEST_EVENT *events;
+	uint64_t count, capacity;
+};
+
+// The log the callbacks are written to
+static struct PETE_TEST_LOG *current_log = NULL;
+
+// Whether each frame is in a candidate range of the pre-screen
+static bool is_in_range[PETE_TEST_FRAMES];
+
+/*
+	Fills a frame with areas that flash in general or in red at different rates,
+	change slowly, stay still, or have noise. The flashing stops in some stretches of frames.
+*/
+static void fill_frame(uint8_t *const data, const int frame, const unsigned seed)
+{
+	srand(seed * 7919 + frame);
+
+	bool is_calm = ((frame + seed * 7) / 25) % 2 == 1;
+
+	for(int y = 0; y < PETE_TEST_HEIGHT; y++)
+	{
+		for(int x = 0; x < PETE_TEST_WIDTH; x++)
+		{
+			uint8_t *const pixel = &data[(y * PETE_TEST_WIDTH + x) * 3];
+			int r, g, b;
+
+			int area = (x / 12 + y / 9 * 6 + seed) % 7;
+			if(is_calm && area != 5 && area != 6) area = 3;
+
+			switch(area)
+			{
+			case 0: r = g = b = (frame / (2 + x % 3 + seed % 2)) % 2 ? 230 : 20; break;
+			case 1: r = (frame / 3) % 2 ? 255 : 30; g = b = (frame / 3) % 2 ? 0 : 30; break;
+			case 2: r = rand() % 256; g = rand() % 256; b = rand() % 256; break;
+			case 3: r = (frame % 40 < 20) ? 200 : 0; g = 0; b = x % 2 ? 0 : 10; break;
+			case 4: r = g = b = (frame > 70 && frame < 100 && frame % 4 < 2) ? 250 : 0; break;
+			case 5: r = g = b = 90 + (frame * (x % 5)) % 60; break;
+			default: r = 40 + (x * 3) % 50; g = 60; b = 70 + (y * 5) % 40; break;
+			}
+
+			// Some flashes in otherwise still areas
+			if(!is_calm && rand() % (seed * 3 + 3) == 0) { r = rand() % 2 ? 255 : 0; g = rand() % 40; b = rand() % 20; }
+			if(frame > 110 + seed && area == 6) { r = (frame % 4 < 2) ? 255 : 0; g = b = 0; }
+
+			pixel[0] = r;
+			pixel[1] = g;
+			pixel[2] = b;
+		}
+	}
+}
+
+static void log_event(const int start, const int end, const int x, const int y, const bool is_red, const bool is_over_three_flashes)
+{
+	if(current_log == NULL) return;
+
+	if(current_log->count == current_log->capacity)
+	{
+		current_log->capacity = current_log->capacity == 0 ? 1024 : current_log->capacity * 2;
+		current_log->events = (struct PETE_TEST_EVENT*) realloc(current_log->events, current_log->capacity * sizeof(struct PETE_TEST_EVENT));
+		if(current_log->events == NULL) exit(1);
+	}
+
+	struct PETE_TEST_EVENT event = {
+		.start = start,
+		.end = end,
+		.x = x,
+		.y = y,
+		.is_red = is_red,
+		.is_over_three_flashes = is_over_three_flashes
+	};
+	current_log->events[current_log->count++] = event;
+}
+
+static void log_flash(const int start, const int end, const int x, const int y, const bool is_red, const PETE_CTX *const ctx)
+{
+	log_event(start, end, x, y, is_red, false);
+}
+
+static void log_over_three_flashes(const int start, const int end, const int x, const int y, const bool is_red, const PETE_CTX *const ctx)
+{
+	log_event(start, end, x, y, is_red, true);
+}
+
+static bool are_events_equal(const struct PETE_TEST_EVENT *const a, const struct PETE_TEST_EVENT *const b)
+{
+	return a->start == b->start && a->end == b->end && a->x == b->x && a->y == b->y &&
+		a->is_red == b->is_red && a->is_over_three_flashes == b->is_over_three_flashes;
+}
+
+static void mark_range(const int start, const int end, const PETE_SCREEN *const screen)
+{
+	for(int i = start; i <= end && i < PETE_TEST_FRAMES; i++)
+	{
+		is_in_range[i] = true;
+	}
+}
+
+/*
+	Returns whether two logs have the same events in the same order
+*/
+static bool are_logs_equal(const struct PETE_TEST_LOG *const a, const struct PETE_TEST_LOG *const b)
+{
+	if(a->count != b->count) return false;
+
+	for(uint64_t i = 0; i < a->count; i++)
+	{
+		if(!are_events_equal(&a->events[i], &b->events[i])) return false;
+	}
+
+	return true;
+}
+
+/*
+	Analyzes the whole video, seeking to the given frame before the first one if it's not negative
+*/
+static void analyze(uint8_t **const frames, const int seek_frame, struct PETE_TEST_LOG *const log)
+{
+	PETE_CTX *ctx = pete_create_context(PETE_TEST_WIDTH, PETE_TEST_HEIGHT, PETE_TEST_FPS, false);
+	if(ctx == NULL) exit(1);
+
+	if(seek_frame >= 0) pete_seek(seek_frame, ctx);
+
+	current_log = log;
+	for(int i = 0; i < PETE_TEST_FRAMES; i++)
+	{
+		pete_receive_frame(frames[i], ctx);
+	}
+	current_log = NULL;
+
+	pete_free_ctx(ctx);
+}
+
+/*
+	Seeking to the first frame must be the same as not seeking at all
+*/
+static bool check_seek_to_start(uint8_t **const frames)
+{
+	struct PETE_TEST_LOG full = { 0 }, seeked = { 0 };
+
+	analyze(frames, -1, &full);
+	analyze(frames, 0, &seeked);
+
+	bool is_equal = are_logs_equal(&full, &seeked);
+
+	free(full.events);
+	free(seeked.events);
+
+	return is_equal;
+}
+
+/*
+	Analyzing only the candidate ranges, skipping the frames outside of them, must report
+	the same callbacks as the full analysis within them, and every over three flashes
+*/
+static bool check_ranges(uint8_t **const frames)
+{
+	PETE_SCREEN *screen = pete_create_screen(PETE_TEST_WIDTH, PETE_TEST_HEIGHT, PETE_TEST_FPS, false);
+	if(screen == NULL) exit(1);
+
+	memset(is_in_range, 0, sizeof(is_in_range));
+	for(int i = 0; i < PETE_TEST_FRAMES; i++)
+	{
+		pete_screen_frame(frames[i], screen);
+	}
+	pete_finish_screen(screen);
+	pete_free_screen(screen);
+
+	struct PETE_TEST_LOG full = { 0 }, expected = { 0 }, ranges = { 0 };
+	analyze(frames, -1, &full);
+
+	for(uint64_t i = 0; i < full.count; i++)
+	{
+		const struct PETE_TEST_EVENT *const event = &full.events[i];
+		if(is_in_range[event->end])
+		{
+			current_log = &expected;
+			log_event(event->start, event->end, event->x, event->y, event->is_red, event->is_over_three_flashes);
+		}
+		else if(event->is_over_three_flashes)
+		{
+			// The pre-screen missed it
+			expected.count = UINT64_MAX;
+			break;
+		}
+	}
+
+	PETE_CTX *ctx = pete_create_context(PETE_TEST_WIDTH, PETE_TEST_HEIGHT, PETE_TEST_FPS, false);
+	if(ctx == NULL) exit(1);
+
+	current_log = &ranges;
+	for(int i = 0; i < PETE_TEST_FRAMES;)
+	{
+		// Skip every frame up to the next range at once
+		int count = 0;
+		while(i + count < PETE_TEST_FRAMES && !is_in_range[i + count]) count++;
+
+		if(count > 0) pete_skip_frames(&frames[i], count, ctx);
+		else pete_receive_frame(frames[i], ctx);
+
+		i += count > 0 ? count : 1;
+	}
+	current_log = NULL;
+	pete_free_ctx(ctx);
+
+	bool is_equal = expected.count != UINT64_MAX && are_logs_equal(&expected, &ranges);
+
+	free(full.events);
+	free(expected.events);
+	free(ranges.events);
+
+	return is_equal;
+}
+
+int main(void)
+{
+	pete_notify_flash = log_flash;
+	pete_notify_over_three_flashes = log_over_three_flashes;
+	pete_notify_candidate_range = mark_range;
+
+	uint8_t *frames[PETE_TEST_FRAMES];
+	for(int i = 0; i < PETE_TEST_FRAMES; i++)
+	{
+		frames[i] = (uint8_t*) malloc(PETE_TEST_WIDTH * PETE_TEST_HEIGHT * 3);
+		if(frames[i] == NULL) return 1;
+	}
+
+	int failures = 0;
+	for(unsigned seed = 0; seed < PETE_TEST_SEEDS; seed++)
+	{
+		for(int i = 0; i < PETE_TEST_FRAMES; i++)
+		{
+			fill_frame(frames[i], i, seed);
+		}
+
+		if(!check_seek_to_start(frames))
+		{
+			printf("FAIL: seeking to the first frame changes the flashes found (video %u)\n", seed);
+			failures++;
+		}
+
+		if(!check_ranges(frames))
+		{
+			printf("FAIL: analyzing the candidate ranges doesn't find the same flashes in them (video %u)\n", seed);
+			failures++;
+		}
+	}
+
+	for(int i = 0; i < PETE_TEST_FRAMES; i++) free(frames[i]);
+
+	if(failures > 0) return 1;
+
+	printf("All checks passed\n");
+	return 0;
+}